@@ -0,0 +1,579 @@
+#include "../Common/mpmc_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <queue>
+#include <sched.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+// Набор микротестов для примитивов синхронизации из Lab_1 и Lab_2:
+//   output_lock     - общий cout_mutex вокруг вывода из рабочих потоков;
+//   partial_results - соседние слоты результатов в одном векторе;
+//   task_queue      - одна очередь задач под queue_mutex + queue_cond,
+//                     в которую производитель кладёт задачи во время работы.
+// Каждый шаблон сравнивается с шардированным, выровненным по кэш-линии и
+// lock-free вариантами. Результат - CSV в stdout.
+
+// Аппаратные счётчики через perf_event_open (наследуются рабочими потоками).
+// inherit действует только на потоки, созданные после открытия события,
+// поэтому счётчики открываются (выключенными) до запуска потоков замера,
+// а включаются перед стартом. Объект создаётся заново для каждого замера:
+// вклад завершившихся потоков предыдущего замера в сумму не попадает.
+class PerfCounters {
+public:
+  static const int COUNT = 4;
+
+  PerfCounters() {
+    const uint32_t types[COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                   PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE};
+    const uint64_t configs[COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_SW_CONTEXT_SWITCHES};
+    for (int i = 0; i < COUNT; i++) {
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = types[i];
+      attr.config = configs[i];
+      attr.disabled = 1;
+      attr.inherit = 1;
+      // Переключения контекста происходят в ядре: с exclude_kernel
+      // программный счётчик всегда показывал бы 0
+      attr.exclude_kernel = types[i] == PERF_TYPE_HARDWARE;
+      attr.exclude_hv = 1;
+      fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fds[i] == -1 && !warned) {
+        std::cerr << "perf_event_open unavailable for some counters ("
+                  << strerror(errno) << "), their columns are empty"
+                  << std::endl;
+        warned = true;
+      }
+    }
+  }
+
+  ~PerfCounters() {
+    for (int fd : fds) {
+      if (fd != -1)
+        close(fd);
+    }
+  }
+
+  void start() {
+    for (int fd : fds) {
+      if (fd != -1) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  void stop() {
+    for (int fd : fds) {
+      if (fd != -1)
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  // Значение счётчика i или пустая строка, если счётчик недоступен
+  std::string value(int i) const {
+    uint64_t count;
+    if (fds[i] == -1 || read(fds[i], &count, sizeof(count)) != sizeof(count))
+      return "";
+    return std::to_string(count);
+  }
+
+private:
+  int fds[COUNT];
+  static bool warned;
+};
+
+bool PerfCounters::warned = false;
+
+// Описание одного варианта: setup готовит общее состояние, worker
+// выполняется в каждом потоке, teardown освобождает состояние
+struct BenchCase {
+  const char *pattern;
+  const char *variant;
+  void (*setup)(unsigned int threads_count, unsigned int ops);
+  void (*worker)(unsigned int thread_index, unsigned int ops);
+  void (*teardown)();
+};
+
+struct alignas(64) PaddedFloat {
+  float value;
+};
+
+struct alignas(64) PaddedMutex {
+  std::mutex mutex;
+};
+
+unsigned int g_threads_count;
+std::atomic<uint64_t> g_checksum; // Не даёт компилятору выбросить работу
+
+// ---------------------------------------------------------------------------
+// output_lock: каждый поток формирует строку отчёта и отдаёт её в общий вывод.
+// Вместо cout используется общий буфер, чтобы измерять блокировку, а не I/O.
+
+const size_t LOG_LIMIT = 1 << 20;
+std::mutex cout_mutex;
+std::string shared_log;
+std::vector<std::string> local_logs;
+std::unique_ptr<char[]> lockfree_log;
+std::atomic<size_t> lockfree_pos;
+
+int format_record(char *buf, size_t size, unsigned int thread_index,
+                  unsigned int i) {
+  return snprintf(buf, size, "Thread %u execution time: %u us\n",
+                  thread_index + 1, i);
+}
+
+void append_shared(const char *data, size_t length) {
+  if (shared_log.size() + length > LOG_LIMIT)
+    shared_log.clear();
+  shared_log.append(data, length);
+}
+
+void output_setup(unsigned int threads_count, unsigned int) {
+  shared_log.clear();
+  shared_log.reserve(LOG_LIMIT + 4096);
+  local_logs.assign(threads_count, std::string());
+  lockfree_log.reset(new char[LOG_LIMIT]);
+  lockfree_pos.store(0);
+}
+
+void output_teardown() {
+  g_checksum += shared_log.size() + lockfree_pos.load();
+  shared_log.clear();
+  local_logs.clear();
+  lockfree_log.reset();
+}
+
+// Как в Lab_1/Lab_2: форматирование и вывод под одним глобальным мьютексом
+void output_global_mutex(unsigned int thread_index, unsigned int ops) {
+  char buf[64];
+  for (unsigned int i = 0; i < ops; i++) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    int length = format_record(buf, sizeof(buf), thread_index, i);
+    append_shared(buf, length);
+  }
+}
+
+// Свой буфер у каждого потока, под мьютексом - только пачки по 64 записи
+void output_sharded(unsigned int thread_index, unsigned int ops) {
+  char buf[64];
+  std::string &local = local_logs[thread_index];
+  for (unsigned int i = 0; i < ops; i++) {
+    int length = format_record(buf, sizeof(buf), thread_index, i);
+    local.append(buf, length);
+    if ((i + 1) % 64 == 0 || i + 1 == ops) {
+      std::lock_guard<std::mutex> lock(cout_mutex);
+      append_shared(local.data(), local.size());
+      local.clear();
+    }
+  }
+}
+
+// Место в общем буфере резервируется атомарным fetch_add
+void output_lockfree(unsigned int thread_index, unsigned int ops) {
+  char buf[64];
+  for (unsigned int i = 0; i < ops; i++) {
+    int length = format_record(buf, sizeof(buf), thread_index, i);
+    size_t pos = lockfree_pos.fetch_add(length) % LOG_LIMIT;
+    if (pos + length <= LOG_LIMIT)
+      std::memcpy(lockfree_log.get() + pos, buf, length);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// partial_results: поток постоянно обновляет свой слот результата.
+// volatile заставляет каждую итерацию выполнять запись в память.
+
+std::vector<float> adjacent_results;
+std::unique_ptr<PaddedFloat[]> padded_results;
+
+void partial_setup(unsigned int threads_count, unsigned int) {
+  adjacent_results.assign(threads_count, 0.0f);
+  padded_results.reset(new PaddedFloat[threads_count]());
+}
+
+void partial_teardown() {
+  for (unsigned int i = 0; i < g_threads_count; i++)
+    g_checksum += static_cast<uint64_t>(adjacent_results[i] +
+                                        padded_results[i].value);
+  padded_results.reset();
+}
+
+// Худший случай, которого в лабораторных нет: запись в соседний слот на
+// каждой итерации (слоты потоков делят одну кэш-линию)
+void partial_adjacent(unsigned int thread_index, unsigned int ops) {
+  volatile float *slot = &adjacent_results[thread_index];
+  for (unsigned int i = 0; i < ops; i++)
+    *slot = *slot + 1.0f;
+}
+
+void partial_padded(unsigned int thread_index, unsigned int ops) {
+  volatile float *slot = &padded_results[thread_index].value;
+  for (unsigned int i = 0; i < ops; i++)
+    *slot = *slot + 1.0f;
+}
+
+// Как в Lab_2/main.cpp (reduce_thread_job): накопление в локальной
+// переменной и одна запись в соседний слот в конце
+void partial_local(unsigned int thread_index, unsigned int ops) {
+  volatile float result = 0.0f;
+  for (unsigned int i = 0; i < ops; i++)
+    result = result + 1.0f;
+  adjacent_results[thread_index] = result;
+}
+
+// ---------------------------------------------------------------------------
+// task_queue: ops * threads_count задач разбираются рабочими потоками.
+// Варианты *_producer получают задачи от отдельного потока-производителя
+// во время замера, остальные - из очереди, заполненной заранее (так
+// измеряется только извлечение). Задача - номер, прибавляемый к сумме.
+
+std::queue<uint32_t> task_queue;
+pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+std::vector<std::queue<uint32_t>> shard_queues;
+std::unique_ptr<PaddedMutex[]> shard_mutexes;
+std::unique_ptr<char[]> ring_memory;
+MpmcRing<uint32_t> *task_ring;
+alignas(64) std::atomic<uint32_t> next_task;
+uint32_t tasks_total;
+bool queue_finished;
+std::atomic<bool> producer_done;
+
+void queue_setup(unsigned int threads_count, unsigned int ops) {
+  tasks_total = ops * threads_count;
+  task_queue = std::queue<uint32_t>();
+  shard_queues.assign(threads_count, std::queue<uint32_t>());
+  shard_mutexes.reset(new PaddedMutex[threads_count]);
+
+  size_t capacity = 1;
+  while (capacity < tasks_total)
+    capacity <<= 1;
+  ring_memory.reset(new char[MpmcRing<uint32_t>::bytes_for(capacity) + 64]);
+  void *aligned = reinterpret_cast<void *>(
+      (reinterpret_cast<uintptr_t>(ring_memory.get()) + 63) & ~uintptr_t(63));
+  task_ring = MpmcRing<uint32_t>::create(aligned, capacity);
+  next_task.store(0);
+  queue_finished = false;
+  producer_done.store(false);
+}
+
+void queue_teardown() {
+  task_queue = std::queue<uint32_t>();
+  shard_queues.clear();
+  shard_mutexes.reset();
+  ring_memory.reset();
+}
+
+void fill_mutex_queue(unsigned int, unsigned int) {
+  for (uint32_t task = 0; task < tasks_total; task++)
+    task_queue.push(task);
+}
+
+void fill_sharded_queues(unsigned int threads_count, unsigned int) {
+  for (uint32_t task = 0; task < tasks_total; task++)
+    shard_queues[task % threads_count].push(task);
+}
+
+void fill_ring(unsigned int, unsigned int) {
+  for (uint32_t task = 0; task < tasks_total; task++)
+    task_ring->push(task);
+}
+
+// Как в Lab_2/primes.cpp: производитель кладёт задачи по одной под
+// queue_mutex и будит потребителя через queue_cond
+void produce_mutex_cond() {
+  for (uint32_t task = 0; task < tasks_total; task++) {
+    pthread_mutex_lock(&queue_mutex);
+    task_queue.push(task);
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+  }
+  pthread_mutex_lock(&queue_mutex);
+  queue_finished = true;
+  pthread_cond_broadcast(&queue_cond);
+  pthread_mutex_unlock(&queue_mutex);
+}
+
+// Потребители ждут в pthread_cond_wait, пока очередь пуста
+void queue_mutex_cond(unsigned int, unsigned int) {
+  uint64_t sum = 0;
+  while (true) {
+    pthread_mutex_lock(&queue_mutex);
+    while (task_queue.empty() && !queue_finished)
+      pthread_cond_wait(&queue_cond, &queue_mutex);
+    if (task_queue.empty()) {
+      pthread_mutex_unlock(&queue_mutex);
+      break;
+    }
+    uint32_t task = task_queue.front();
+    task_queue.pop();
+    pthread_mutex_unlock(&queue_mutex);
+    sum += task;
+  }
+  g_checksum += sum;
+}
+
+// Тот же queue_mutex без производителя: очередь заполнена заранее
+void queue_mutex_prefilled(unsigned int, unsigned int) {
+  uint64_t sum = 0;
+  while (true) {
+    pthread_mutex_lock(&queue_mutex);
+    if (task_queue.empty()) {
+      pthread_mutex_unlock(&queue_mutex);
+      break;
+    }
+    uint32_t task = task_queue.front();
+    task_queue.pop();
+    pthread_mutex_unlock(&queue_mutex);
+    sum += task;
+  }
+  g_checksum += sum;
+}
+
+// Производитель для lock-free кольца: при переполнении уступает процессор
+void produce_ring() {
+  for (uint32_t task = 0; task < tasks_total; task++) {
+    while (!task_ring->push(task))
+      sched_yield();
+  }
+  producer_done.store(true, std::memory_order_release);
+}
+
+// Потребители кольца не спят, а уступают процессор, пока задач нет
+void queue_ring_producer(unsigned int, unsigned int) {
+  uint64_t sum = 0;
+  uint32_t task;
+  while (true) {
+    if (task_ring->pop(task)) {
+      sum += task;
+      continue;
+    }
+    if (producer_done.load(std::memory_order_acquire)) {
+      // Производитель закончил: дочитываем остаток и выходим
+      if (!task_ring->pop(task))
+        break;
+      sum += task;
+      continue;
+    }
+    sched_yield();
+  }
+  g_checksum += sum;
+}
+
+// Своя очередь у каждого потока, по опустошении - кража у соседей
+void queue_sharded(unsigned int thread_index, unsigned int) {
+  uint64_t sum = 0;
+  for (unsigned int k = 0; k < g_threads_count; k++) {
+    unsigned int shard = (thread_index + k) % g_threads_count;
+    while (true) {
+      std::unique_lock<std::mutex> lock(shard_mutexes[shard].mutex);
+      if (shard_queues[shard].empty())
+        break;
+      uint32_t task = shard_queues[shard].front();
+      shard_queues[shard].pop();
+      lock.unlock();
+      sum += task;
+    }
+  }
+  g_checksum += sum;
+}
+
+// Lock-free кольцо из Common/mpmc_ring.h
+void queue_ring(unsigned int, unsigned int) {
+  uint64_t sum = 0;
+  uint32_t task;
+  while (task_ring->pop(task))
+    sum += task;
+  g_checksum += sum;
+}
+
+// Раздача номеров задач атомарным счётчиком
+void queue_atomic_counter(unsigned int, unsigned int) {
+  uint64_t sum = 0;
+  while (true) {
+    uint32_t task = next_task.fetch_add(1, std::memory_order_relaxed);
+    if (task >= tasks_total)
+      break;
+    sum += task;
+  }
+  g_checksum += sum;
+}
+
+// ---------------------------------------------------------------------------
+// Запуск: потоки создаются заранее и стартуют одновременно, поэтому
+// измеряется только работа, без создания потоков
+
+struct WorkerParams {
+  const BenchCase *bench;
+  unsigned int thread_index;
+  unsigned int ops;
+};
+
+std::atomic<unsigned int> ready_count;
+std::atomic<bool> go;
+
+void wait_for_go() {
+  ready_count.fetch_add(1);
+  while (!go.load(std::memory_order_acquire))
+    sched_yield();
+}
+
+void *bench_thread_job(void *arg) {
+  WorkerParams *params = static_cast<WorkerParams *>(arg);
+  wait_for_go();
+  params->bench->worker(params->thread_index, params->ops);
+  return nullptr;
+}
+
+void *producer_thread_job(void *arg) {
+  void (*producer)() = reinterpret_cast<void (*)()>(arg);
+  wait_for_go();
+  producer();
+  return nullptr;
+}
+
+// producer - необязательный поток-производитель, работающий во время
+// замера; в столбце threads он не учитывается
+void run_case(const BenchCase &bench,
+              void (*prefill)(unsigned int, unsigned int),
+              void (*producer)(), unsigned int threads_count,
+              unsigned int ops) {
+  g_threads_count = threads_count;
+  bench.setup(threads_count, ops);
+  if (prefill)
+    prefill(threads_count, ops);
+
+  // До pthread_create, иначе потоки не унаследуют счётчики
+  PerfCounters counters;
+  std::vector<pthread_t> threads(threads_count);
+  std::vector<WorkerParams> params(threads_count);
+  ready_count.store(0);
+  go.store(false);
+  for (unsigned int i = 0; i < threads_count; ++i) {
+    params[i] = {&bench, i, ops};
+    pthread_create(&threads[i], nullptr, bench_thread_job, &params[i]);
+  }
+  if (producer) {
+    threads.emplace_back();
+    pthread_create(&threads.back(), nullptr, producer_thread_job,
+                   reinterpret_cast<void *>(producer));
+  }
+  while (ready_count.load() < threads.size())
+    sched_yield();
+
+  // RESET/ENABLE на родительском событии доходят и до унаследованных
+  counters.start();
+  auto start = high_resolution_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &thread : threads) {
+    pthread_join(thread, nullptr);
+  }
+  auto end = high_resolution_clock::now();
+  counters.stop();
+  bench.teardown();
+
+  double seconds = duration<double>(end - start).count();
+  uint64_t total_ops = uint64_t(ops) * threads_count;
+  std::cout << bench.pattern << "," << bench.variant << "," << threads_count
+            << "," << total_ops << "," << seconds << ","
+            << seconds * 1e9 / total_ops << "," << total_ops / seconds / 1e6;
+  for (int i = 0; i < PerfCounters::COUNT; i++)
+    std::cout << "," << counters.value(i);
+  std::cout << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " [max_threads] [ops_per_thread]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  unsigned int max_threads = argc > 1 ? atoi(argv[1]) : 64;
+  unsigned int ops = argc > 2 ? atoi(argv[2]) : 50000;
+  if (max_threads == 0 || ops == 0) {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  struct Entry {
+    BenchCase bench;
+    void (*prefill)(unsigned int, unsigned int);
+    void (*producer)();
+  };
+  const Entry entries[] = {
+      {{"output_lock", "global_mutex", output_setup, output_global_mutex,
+        output_teardown},
+       nullptr, nullptr},
+      {{"output_lock", "sharded_batches", output_setup, output_sharded,
+        output_teardown},
+       nullptr, nullptr},
+      {{"output_lock", "lockfree_reserve", output_setup, output_lockfree,
+        output_teardown},
+       nullptr, nullptr},
+      {{"partial_results", "adjacent_every_iteration", partial_setup,
+        partial_adjacent, partial_teardown},
+       nullptr, nullptr},
+      {{"partial_results", "padded_every_iteration", partial_setup,
+        partial_padded, partial_teardown},
+       nullptr, nullptr},
+      {{"partial_results", "local_then_adjacent_store", partial_setup,
+        partial_local, partial_teardown},
+       nullptr, nullptr},
+      {{"task_queue", "mutex_cond_producer", queue_setup, queue_mutex_cond,
+        queue_teardown},
+       nullptr, produce_mutex_cond},
+      {{"task_queue", "lockfree_ring_producer", queue_setup,
+        queue_ring_producer, queue_teardown},
+       nullptr, produce_ring},
+      {{"task_queue", "mutex_prefilled", queue_setup, queue_mutex_prefilled,
+        queue_teardown},
+       fill_mutex_queue, nullptr},
+      {{"task_queue", "sharded_stealing", queue_setup, queue_sharded,
+        queue_teardown},
+       fill_sharded_queues, nullptr},
+      {{"task_queue", "lockfree_ring", queue_setup, queue_ring,
+        queue_teardown},
+       fill_ring, nullptr},
+      {{"task_queue", "atomic_counter", queue_setup, queue_atomic_counter,
+        queue_teardown},
+       nullptr, nullptr},
+  };
+
+  std::cout << "pattern,variant,threads,ops,seconds,ns_per_op,mops_per_s,"
+               "cycles,instructions,cache_misses,context_switches"
+            << std::endl;
+  for (const Entry &entry : entries) {
+    for (unsigned int threads_count = 1; threads_count <= max_threads;
+         threads_count *= 2) {
+      run_case(entry.bench, entry.prefill, entry.producer, threads_count,
+               ops);
+    }
+  }
+
+  // Контрольная сумма выводится в stderr, чтобы не портить CSV
+  std::cerr << "checksum: " << g_checksum.load() << std::endl;
+  return EXIT_SUCCESS;
+}
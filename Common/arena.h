@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// Арена для больших рабочих массивов.
+// Каждый блок - отдельное анонимное отображение, по возможности на огромных
+// страницах. Освобождённые блоки не возвращаются системе, а переиспользуются
+// следующими запросами, поэтому повторные прогоны не платят за page fault.
+//
+// Переменные окружения:
+//   ARENA_HUGEPAGES = off | thp (по умолчанию) | 2m | 1g
+//     thp    - обычное отображение, выровненное по 2 МБ, с MADV_HUGEPAGE;
+//     2m, 1g - MAP_HUGETLB; если зарезервированных страниц нет, арена
+//              откатывается на 2m, затем на thp.
+//   ARENA_PREFAULT = 1 - заполнять страницы заранее в несколько потоков.
+//     Заполняют их вспомогательные потоки арены в момент выделения, а не
+//     сами рабочие потоки: в лабораторных рабочие потоки создаются заново на
+//     каждом этапе и не привязаны к ядрам, так что размещение страниц по
+//     узлам NUMA с конкретным рабочим потоком всё равно не связано.
+class Arena {
+public:
+  static const size_t HUGE_2MB = size_t(2) << 20;
+  static const size_t HUGE_1GB = size_t(1) << 30;
+
+  enum class Mode { Off, Thp, Huge2M, Huge1G };
+
+  struct Stats {
+    size_t mapped_bytes = 0;    // Всего отображено
+    size_t hugetlb_bytes = 0;   // Из них через MAP_HUGETLB
+    unsigned int mappings = 0;  // Новых отображений
+    unsigned int reused = 0;    // Запросов, обслуженных повторно
+    long long prefault_us = 0;  // Время предварительного заполнения
+    // Отображения по фактически полученному режиму (индекс - Mode)
+    unsigned int mappings_by_mode[4] = {0, 0, 0, 0};
+    unsigned int fallbacks = 0; // Отказов MAP_HUGETLB с откатом на режим ниже
+  };
+
+  static Arena &instance() {
+    static Arena arena;
+    return arena;
+  }
+
+  // Выделение bytes байт; prefault_threads > 0 - заполнить страницы заранее
+  void *allocate(size_t bytes, unsigned int prefault_threads = 0) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bytes = std::max<size_t>(bytes, 1);
+
+    // Наименьший свободный блок подходящего размера, но не больше чем
+    // вдвое: иначе маленький запрос заберёт и удержит большой блок, а
+    // следующий большой запрос отобразит память заново
+    Block *best = nullptr;
+    for (Block &block : blocks) {
+      if (!block.in_use && block.capacity >= bytes &&
+          block.capacity <= 2 * round_up(bytes, page_size) &&
+          (!best || block.capacity < best->capacity))
+        best = &block;
+    }
+    if (best) {
+      best->in_use = true;
+      stats.reused++;
+      return best->ptr;
+    }
+
+    Block block = map_block(bytes);
+    block.in_use = true;
+    if (prefault_enabled && prefault_threads > 0)
+      prefault(block.ptr, block.capacity, prefault_threads);
+    blocks.push_back(block);
+    return block.ptr;
+  }
+
+  void deallocate(void *ptr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Block &block : blocks) {
+      if (block.ptr == ptr) {
+        block.in_use = false;
+        return;
+      }
+    }
+  }
+
+  Mode mode() const { return requested_mode; }
+
+  Stats get_stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+  }
+
+  void print_stats(std::ostream &out) {
+    Stats s = get_stats();
+    static const char *mode_names[] = {"off", "thp", "2m", "1g"};
+    out << "Arena: requested mode "
+        << mode_names[static_cast<int>(requested_mode)] << ", mapped "
+        << s.mapped_bytes / 1024 << " KB (" << s.hugetlb_bytes / 1024
+        << " KB hugetlb), mappings " << s.mappings << " (";
+    for (int m = 0; m < 4; m++)
+      out << (m ? ", " : "") << mode_names[m] << " " << s.mappings_by_mode[m];
+    out << "), hugetlb fallbacks " << s.fallbacks << ", reused " << s.reused
+        << ", prefault time " << s.prefault_us << " us" << std::endl;
+  }
+
+  ~Arena() {
+    for (Block &block : blocks)
+      munmap(block.ptr, block.capacity);
+  }
+
+private:
+  struct Block {
+    void *ptr;
+    size_t capacity;
+    bool in_use;
+  };
+
+  struct PrefaultParams {
+    char *begin;
+    size_t bytes;
+    size_t page_size;
+  };
+
+  Arena() {
+    const char *mode_env = getenv("ARENA_HUGEPAGES");
+    std::string mode_name = mode_env ? mode_env : "thp";
+    if (mode_name == "off")
+      requested_mode = Mode::Off;
+    else if (mode_name == "2m")
+      requested_mode = Mode::Huge2M;
+    else if (mode_name == "1g")
+      requested_mode = Mode::Huge1G;
+    else
+      requested_mode = Mode::Thp;
+
+    const char *prefault_env = getenv("ARENA_PREFAULT");
+    prefault_enabled = prefault_env && std::string(prefault_env) == "1";
+    page_size = sysconf(_SC_PAGESIZE);
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  static size_t round_up(size_t value, size_t unit) {
+    return (value + unit - 1) / unit * unit;
+  }
+
+  void *try_hugetlb(size_t bytes, size_t huge_size, int huge_flag) {
+    void *ptr = mmap(nullptr, round_up(bytes, huge_size),
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge_flag, -1,
+                     0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  Block map_block(size_t bytes) {
+    Block block = {nullptr, 0, false};
+    Mode actual_mode = Mode::Off;
+
+    // MAP_HUGETLB: 1 ГБ -> 2 МБ, иначе откат на обычные страницы
+    if (requested_mode == Mode::Huge1G && bytes >= HUGE_1GB / 2) {
+      block.ptr = try_hugetlb(bytes, HUGE_1GB, MAP_HUGE_1GB);
+      block.capacity = round_up(bytes, HUGE_1GB);
+      actual_mode = Mode::Huge1G;
+      if (!block.ptr)
+        stats.fallbacks++;
+    }
+    if (!block.ptr &&
+        (requested_mode == Mode::Huge1G || requested_mode == Mode::Huge2M)) {
+      block.ptr = try_hugetlb(bytes, HUGE_2MB, MAP_HUGE_2MB);
+      block.capacity = round_up(bytes, HUGE_2MB);
+      actual_mode = Mode::Huge2M;
+      if (!block.ptr)
+        stats.fallbacks++;
+    }
+    if (block.ptr) {
+      stats.hugetlb_bytes += block.capacity;
+    } else if (requested_mode == Mode::Off || bytes < HUGE_2MB) {
+      actual_mode = Mode::Off;
+      block.capacity = round_up(bytes, page_size);
+      block.ptr = mmap(nullptr, block.capacity, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (block.ptr == MAP_FAILED)
+        throw std::bad_alloc();
+    } else {
+      // Прозрачные огромные страницы: отображение с запасом, выравнивание
+      // начала по 2 МБ и отрезание лишнего
+      block.capacity = round_up(bytes, HUGE_2MB);
+      size_t reserved = block.capacity + HUGE_2MB;
+      char *raw = static_cast<char *>(mmap(nullptr, reserved,
+                                           PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+      if (raw == MAP_FAILED)
+        throw std::bad_alloc();
+      char *aligned = reinterpret_cast<char *>(
+          round_up(reinterpret_cast<size_t>(raw), HUGE_2MB));
+      if (aligned > raw)
+        munmap(raw, aligned - raw);
+      size_t tail = (raw + reserved) - (aligned + block.capacity);
+      if (tail > 0)
+        munmap(aligned + block.capacity, tail);
+      madvise(aligned, block.capacity, MADV_HUGEPAGE); // Ошибка не критична
+      block.ptr = aligned;
+      actual_mode = Mode::Thp;
+    }
+
+    stats.mappings_by_mode[static_cast<int>(actual_mode)]++;
+    stats.mapped_bytes += block.capacity;
+    stats.mappings++;
+    return block;
+  }
+
+  static void *prefault_job(void *arg) {
+    PrefaultParams *params = static_cast<PrefaultParams *>(arg);
+    for (size_t offset = 0; offset < params->bytes;
+         offset += params->page_size)
+      params->begin[offset] = 0;
+    return nullptr;
+  }
+
+  // Заполнение страниц блока в threads_count потоков (диапазоны кратны
+  // размеру страницы, чтобы потоки не делили одну огромную страницу)
+  void prefault(void *ptr, size_t bytes, unsigned int threads_count) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    size_t unit = bytes >= HUGE_2MB ? HUGE_2MB : page_size;
+    size_t units = (bytes + unit - 1) / unit;
+    threads_count = std::max<size_t>(1, std::min<size_t>(threads_count, units));
+    size_t units_per_thread = units / threads_count;
+    size_t rest = units % threads_count;
+
+    std::vector<pthread_t> threads(threads_count);
+    std::vector<PrefaultParams> params(threads_count);
+    size_t begin = 0;
+    for (unsigned int i = 0; i < threads_count; ++i) {
+      size_t length = (units_per_thread + (i < rest ? 1 : 0)) * unit;
+      length = std::min(length, bytes - begin);
+      params[i] = {static_cast<char *>(ptr) + begin, length, page_size};
+      begin += length;
+      pthread_create(&threads[i], nullptr, prefault_job, &params[i]);
+    }
+    for (auto &thread : threads) {
+      pthread_join(thread, nullptr);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    stats.prefault_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count();
+  }
+
+  std::mutex mutex;
+  std::vector<Block> blocks;
+  Stats stats;
+  Mode requested_mode;
+  bool prefault_enabled;
+  size_t page_size;
+};
+
+// Аллокатор для std::vector поверх общей арены
+template <typename T> struct ArenaAllocator {
+  using value_type = T;
+
+  unsigned int prefault_threads = 0;
+
+  ArenaAllocator() = default;
+  explicit ArenaAllocator(unsigned int prefault_threads)
+      : prefault_threads(prefault_threads) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other)
+      : prefault_threads(other.prefault_threads) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(
+        Arena::instance().allocate(n * sizeof(T), prefault_threads));
+  }
+
+  void deallocate(T *ptr, size_t) { Arena::instance().deallocate(ptr); }
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &) const {
+    return true;
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U> &) const {
+    return false;
+  }
+};
+
+// Массив из арены с автоматическим возвратом блока (замена new T[n])
+struct ArenaDeleter {
+  void operator()(void *ptr) const { Arena::instance().deallocate(ptr); }
+};
+
+template <typename T> using ArenaArray = std::unique_ptr<T[], ArenaDeleter>;
+
+template <typename T>
+ArenaArray<T> make_arena_array(size_t n, unsigned int prefault_threads = 0) {
+  return ArenaArray<T>(
+      static_cast<T *>(Arena::instance().allocate(n * sizeof(T),
+                                                  prefault_threads)));
+}
+
+// Счётчики page fault процесса между созданием объекта и print()
+class PageFaultReport {
+public:
+  PageFaultReport() { reset(); }
+
+  void reset() {
+    start = std::chrono::high_resolution_clock::now();
+    read_faults(minor_start, major_start);
+  }
+
+  void print(std::ostream &out, const std::string &label) const {
+    long minor, major;
+    read_faults(minor, major);
+    auto end = std::chrono::high_resolution_clock::now();
+    out << label << ": page faults minor " << minor - minor_start << ", major "
+        << major - major_start << ", time "
+        << std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+               .count()
+        << " us" << std::endl;
+  }
+
+private:
+  static void read_faults(long &minor, long &major) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    minor = usage.ru_minflt;
+    major = usage.ru_majflt;
+  }
+
+  std::chrono::high_resolution_clock::time_point start;
+  long minor_start;
+  long major_start;
+};
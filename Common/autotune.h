@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Профиль машины для одного вычислительного ядра (kernel)
+struct TuneProfile {
+  double spawn_us;   // Создание и join одного потока
+  double sync_ns;    // Пара lock/unlock мьютекса
+  double element_ns; // Обработка одного элемента одним потоком
+  double cpu_ratio;  // Доля процессорного времени (< 1 - поток ждёт)
+};
+
+// Подбор количества потоков и размера порции по коротким калибровочным
+// замерам. Профиль сохраняется в файл (AUTOTUNE_PROFILE, по умолчанию
+// autotune.profile) с ключом "ядро + число аппаратных потоков", поэтому
+// следующие запуски не повторяют замеры. AUTOTUNE_REFRESH=1 - замерить
+// заново.
+class Autotuner {
+public:
+  explicit Autotuner(const std::string &kernel)
+      : kernel(kernel), hw_threads(std::max(
+                            1u, std::thread::hardware_concurrency())) {
+    const char *path_env = getenv("AUTOTUNE_PROFILE");
+    path = path_env ? path_env : "autotune.profile";
+  }
+
+  // Профиль из файла либо калибровка. probe(count) должен обработать count
+  // элементов так же, как это делает рабочий поток
+  template <typename Probe>
+  const TuneProfile &calibrate(Probe &&probe, size_t max_probe_elements) {
+    const char *refresh_env = getenv("AUTOTUNE_REFRESH");
+    bool refresh = refresh_env && std::string(refresh_env) == "1";
+    if (!refresh && load())
+      return tuned;
+
+    tuned.spawn_us = measure_spawn_us();
+    tuned.sync_ns = measure_sync_ns();
+
+    // Увеличиваем пробу, пока она не станет заметно длиннее шума таймера
+    size_t count = 1;
+    double wall_ns = 0, cpu_ns = 0;
+    while (true) {
+      double cpu_start = thread_cpu_ns();
+      auto start = std::chrono::high_resolution_clock::now();
+      probe(count);
+      auto end = std::chrono::high_resolution_clock::now();
+      cpu_ns = thread_cpu_ns() - cpu_start;
+      wall_ns = std::chrono::duration<double, std::nano>(end - start).count();
+      if (wall_ns >= 2e6 || count >= max_probe_elements)
+        break;
+      count = std::min(count * 2, max_probe_elements);
+    }
+    tuned.element_ns = wall_ns / count;
+    tuned.cpu_ratio = wall_ns > 0 ? std::min(1.0, cpu_ns / wall_ns) : 1.0;
+    save();
+    return tuned;
+  }
+
+  // Число потоков для n элементов: минимум модели
+  //   T(p) = n * element / p + p * spawn,
+  // т.е. p = sqrt(n * element / spawn). Выше числа ядер идём, только если
+  // ядро большую часть времени ждёт (cpu_ratio < 1)
+  unsigned int pick_threads(size_t n) const {
+    double work_us = n * tuned.element_ns / 1000.0;
+    double best = std::sqrt(work_us / std::max(tuned.spawn_us, 1e-3));
+    double cap = tuned.cpu_ratio >= 0.5
+                     ? hw_threads
+                     : hw_threads / std::max(tuned.cpu_ratio, 0.01);
+    best = std::min({std::round(best), cap, static_cast<double>(n)});
+    return static_cast<unsigned int>(std::max(1.0, best));
+  }
+
+  // Размер порции: не меньше min_chunk и достаточно длинный, чтобы передача
+  // задачи через очередь стоила < 1% её времени; не больше кэша L2
+  // (element_bytes - объём элемента в байтах) и не больше 1/4 доли потока,
+  // чтобы было чем выравнивать нагрузку
+  size_t pick_chunk(size_t n, unsigned int threads_count, size_t min_chunk,
+                    double element_bytes) const {
+    long l2_env = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    double l2_bytes = l2_env > 0 ? l2_env : 256 * 1024;
+    double chunk = n / (4.0 * threads_count);
+    chunk = std::min(chunk, l2_bytes / element_bytes);
+    chunk = std::max(chunk, 100.0 * tuned.sync_ns /
+                                std::max(tuned.element_ns, 1e-3));
+    chunk = std::max(chunk, static_cast<double>(min_chunk));
+    return std::min(static_cast<size_t>(chunk), std::max<size_t>(n, 1));
+  }
+
+  void print(std::ostream &out) const {
+    out << "Autotune (" << kernel << ", " << hw_threads
+        << " hw threads): spawn " << tuned.spawn_us << " us, sync "
+        << tuned.sync_ns << " ns, element " << tuned.element_ns
+        << " ns, cpu ratio " << tuned.cpu_ratio
+        << (loaded ? " (cached)" : " (calibrated)") << std::endl;
+  }
+
+private:
+  static void *empty_job(void *) { return nullptr; }
+
+  // Создание и join пачки потоков, как это делают рабочие программы
+  static double measure_spawn_us() {
+    const unsigned int count = 16;
+    std::vector<pthread_t> threads(count);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto &thread : threads)
+      pthread_create(&thread, nullptr, empty_job, nullptr);
+    for (auto &thread : threads)
+      pthread_join(thread, nullptr);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() /
+           count;
+  }
+
+  static double measure_sync_ns() {
+    const unsigned int count = 100000;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < count; i++) {
+      pthread_mutex_lock(&mutex);
+      pthread_mutex_unlock(&mutex);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           count;
+  }
+
+  static double thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+  }
+
+  std::string key() const { return kernel + "@" + std::to_string(hw_threads); }
+
+  // Строка файла: <ядро>@<hw_threads> spawn_us sync_ns element_ns cpu_ratio
+  bool load() {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+      std::istringstream fields(line);
+      std::string line_key;
+      TuneProfile profile;
+      if (fields >> line_key >> profile.spawn_us >> profile.sync_ns >>
+              profile.element_ns >> profile.cpu_ratio &&
+          line_key == key()) {
+        tuned = profile;
+        loaded = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void save() const {
+    std::vector<std::string> lines;
+    {
+      std::ifstream in(path);
+      std::string line;
+      while (std::getline(in, line)) {
+        if (line.compare(0, key().size() + 1, key() + " ") != 0)
+          lines.push_back(line);
+      }
+    }
+    std::ofstream out(path);
+    if (!out) {
+      std::cerr << "Warning: cannot write autotune profile '" << path << "'"
+                << std::endl;
+      return;
+    }
+    for (const std::string &line : lines)
+      out << line << "\n";
+    out << key() << " " << tuned.spawn_us << " " << tuned.sync_ns << " "
+        << tuned.element_ns << " " << tuned.cpu_ratio << "\n";
+  }
+
+  std::string kernel;
+  std::string path;
+  unsigned int hw_threads;
+  TuneProfile tuned = {0, 0, 0, 1};
+  bool loaded = false;
+};
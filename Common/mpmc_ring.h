@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Ограниченная lock-free очередь MPMC (кольцо Вьюкова).
+// Объект не выделяет память сам: он создаётся поверх заранее выделенного
+// блока, поэтому его можно разместить в разделяемой памяти POSIX и
+// использовать из нескольких процессов после fork().
+// Ограничение: если потребитель погибнет внутри pop() между захватом позиции
+// и освобождением ячейки, ячейка останется занятой, и когда запись дойдёт до
+// неё по кругу, push() будет всегда возвращать false. Восстанавливать такое
+// кольцо должен владелец (см. rebuild_ring в Lab_2/mp_map_reduce.cpp).
+template <typename T> class MpmcRing {
+public:
+  // Размер блока памяти под кольцо ёмкостью capacity (степень двойки)
+  static size_t bytes_for(size_t capacity) {
+    return sizeof(MpmcRing) + capacity * sizeof(Cell);
+  }
+
+  // Создание кольца в памяти mem (выравнивание не меньше 64 байт)
+  static MpmcRing *create(void *mem, size_t capacity) {
+    MpmcRing *ring = new (mem) MpmcRing(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+      new (&ring->cells()[i]) Cell;
+      ring->cells()[i].seq.store(i, std::memory_order_relaxed);
+    }
+    return ring;
+  }
+
+  bool push(const T &value) {
+    uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells()[pos & mask];
+      uint64_t seq = cell.seq.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // Кольцо заполнено
+      } else {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(T &value) {
+    uint64_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells()[pos & mask];
+      uint64_t seq = cell.seq.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          value = cell.value;
+          cell.seq.store(pos + mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // Кольцо пусто
+      } else {
+        pos = dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Приблизительное число элементов (точно только в отсутствие гонок)
+  size_t size_approx() const {
+    uint64_t tail = enqueue_pos.load(std::memory_order_acquire);
+    uint64_t head = dequeue_pos.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+private:
+  struct Cell {
+    std::atomic<uint64_t> seq;
+    T value;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "MpmcRing requires lock-free 64-bit atomics");
+
+  explicit MpmcRing(size_t capacity)
+      : enqueue_pos(0), dequeue_pos(0), mask(capacity - 1) {}
+
+  Cell *cells() { return reinterpret_cast<Cell *>(this + 1); }
+
+  // Позиции записи и чтения разнесены по разным кэш-линиям
+  alignas(64) std::atomic<uint64_t> enqueue_pos;
+  alignas(64) std::atomic<uint64_t> dequeue_pos;
+  alignas(64) uint64_t mask;
+};
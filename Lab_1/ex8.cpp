@@ -1,3 +1,5 @@
+#include "../Common/arena.h"
+#include "../Common/autotune.h"
 #include <iostream>
 #include <pthread.h>
 #include <chrono>
@@ -56,19 +58,41 @@ int main(int argc, char *argv[])
 {
     if (argc < 3)
     {
-        cerr << "Usage: " << argv[0] << " <array_length> <threads_count>" << endl;
+        cerr << "Usage: " << argv[0] << " <array_length> <threads_count|auto>" << endl;
         return EXIT_FAILURE;
     }
 
     unsigned int array_length = atoi(argv[1]);
-    unsigned int threads_count = atoi(argv[2]);
+    unsigned int threads_count;
+    if (string(argv[2]) == "auto")
+    {
+        // Калибровка на временном массиве той же нагрузкой, что и thread_job
+        Autotuner tuner("ex8");
+        auto probe = [](size_t count)
+        {
+            vector<float> probe_arr(count, 1.0f);
+            for (float &x : probe_arr)
+            {
+                x = executable_function(x);
+                usleep(1000); // Симуляция вычислительной нагрузки
+            }
+        };
+        tuner.calibrate(probe, 64);
+        tuner.print(cout);
+        threads_count = tuner.pick_threads(array_length);
+    }
+    else
+    {
+        threads_count = atoi(argv[2]);
+    }
     threads_count = min(threads_count, array_length);
     unsigned int batch_size = array_length / threads_count;
     unsigned int rest = array_length % threads_count;
 
     vector<pthread_t> threads(threads_count);
     vector<ThreadParams> thread_params(threads_count);
-    unique_ptr<float[]> number_arr(new float[array_length]);
+    PageFaultReport fault_report;
+    ArenaArray<float> number_arr = make_arena_array<float>(array_length, threads_count);
     initialize_array(array_length, number_arr.get());
 
     auto start_total = high_resolution_clock::now();
@@ -86,6 +110,8 @@ int main(int argc, char *argv[])
 
     auto end_total = high_resolution_clock::now();
     cout << "Total execution time: " << duration_cast<microseconds>(end_total - start_total).count() << " us" << endl;
+    fault_report.print(cout, "Allocation and processing");
+    Arena::instance().print_stats(cout);
 
     for (unsigned int i = 0; i < array_length; i++)
     {
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Сравнение масштабирования map_reduce на потоках (main.cpp) и
+# многопроцессного исполнителя (mp_map_reduce.cpp) на одной машине.
+# Использование: ./bench_mp_map_reduce.sh [array_length] [max_workers]
+set -e
+
+ARRAY_LENGTH=${1:-2000}
+MAX_WORKERS=${2:-16}
+BUILD_DIR=${BUILD_DIR:-/tmp}
+
+cd "$(dirname "$0")"
+g++ -std=c++17 -O2 -pthread main.cpp -o "$BUILD_DIR/map_reduce"
+g++ -std=c++17 -O2 -pthread mp_map_reduce.cpp -o "$BUILD_DIR/mp_map_reduce"
+
+total_us() {
+  "$@" | sed -n 's/^Total MapReduce execution time: \([0-9]*\) us$/\1/p'
+}
+
+echo "workers,threads_us,processes_us"
+workers=1
+while [ "$workers" -le "$MAX_WORKERS" ]; do
+  threads_us=$(total_us "$BUILD_DIR/map_reduce" "$ARRAY_LENGTH" "$workers")
+  processes_us=$(total_us "$BUILD_DIR/mp_map_reduce" "$ARRAY_LENGTH" "$workers")
+  echo "$workers,$threads_us,$processes_us"
+  workers=$((workers * 2))
+done
@@ -1,3 +1,6 @@
+#include "../Common/arena.h"
+#include "../Common/autotune.h"
+
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -49,7 +52,7 @@ void *map_thread_job(void *arg) {
 
 // Структура для этапа reduce
 struct ReduceThreadParams {
-  std::vector<float> *mapped_data;
+  std::vector<float, ArenaAllocator<float>> *mapped_data;
   unsigned int start_idx;
   unsigned int batch_size;
   float (*reduce_func)(float, float);
@@ -102,8 +105,10 @@ float map_reduce(MapReduceParams *params) {
   }
 
   // Этап 2: Reduce
-  std::vector<float> mapped_data(params->data,
-                                 params->data + params->data_size);
+  // Копия берётся из арены: при повторных прогонах блок переиспользуется
+  std::vector<float, ArenaAllocator<float>> mapped_data(
+      params->data, params->data + params->data_size,
+      ArenaAllocator<float>(params->threads_count));
   std::vector<pthread_t> reduce_threads(params->threads_count);
   std::vector<ReduceThreadParams> reduce_params(params->threads_count);
   std::vector<float> partial_results(params->threads_count, 0.0);
@@ -157,21 +162,47 @@ float reduce_func(float a, float b) {
 
 int main(int argc, char *argv[]) {
   if (argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <array_length> <threads_count>"
-              << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <array_length> <threads_count|auto>"
+              << " [runs]" << std::endl;
     return EXIT_FAILURE;
   }
 
   unsigned int array_length = atoi(argv[1]);
-  unsigned int threads_count = atoi(argv[2]);
+  unsigned int threads_count;
+  if (std::string(argv[2]) == "auto") {
+    // Калибровка на временном массиве той же нагрузкой, что и map
+    Autotuner tuner("map_reduce");
+    tuner.calibrate(
+        [](size_t count) {
+          std::vector<float> probe(count, 1.0f);
+          for (float &x : probe) {
+            x = map_func(x);
+            usleep(1000); // Симуляция вычислительной нагрузки
+          }
+        },
+        64);
+    tuner.print(std::cout);
+    threads_count = tuner.pick_threads(array_length);
+  } else {
+    threads_count = atoi(argv[2]);
+  }
   threads_count = std::min(threads_count, array_length);
+  unsigned int runs = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
 
-  std::unique_ptr<float[]> data(new float[array_length]);
-  initialize_array(array_length, data.get());
+  ArenaArray<float> data =
+      make_arena_array<float>(array_length, threads_count);
 
-  MapReduceParams params = {data.get(), array_length, map_func, reduce_func,
-                            threads_count};
-  float result = map_reduce(&params);
+  float result = 0.0f;
+  for (unsigned int run = 0; run < runs; run++) {
+    PageFaultReport fault_report;
+    initialize_array(array_length, data.get());
+
+    MapReduceParams params = {data.get(), array_length, map_func,
+                              reduce_func, threads_count};
+    result = map_reduce(&params);
+    fault_report.print(std::cout, "Run " + std::to_string(run + 1));
+  }
+  Arena::instance().print_stats(std::cout);
 
   std::cout << "\nMapReduce result: " << result << std::endl;
 
@@ -0,0 +1,430 @@
+#include "../Common/mpmc_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+#define err_exit(code, str)                                                    \
+  {                                                                            \
+    std::cerr << str << ": " << strerror(code) << std::endl;                   \
+    exit(EXIT_FAILURE);                                                        \
+  }
+
+// Состояние чанка: номер слота рабочего процесса (>= 0) либо одно из:
+const int32_t CHUNK_QUEUED = -1; // ожидает в кольце
+const int32_t CHUNK_DONE = -2;   // результат записан
+
+// Запасные области под кольцо: заклинившее кольцо не чинится, а заменяется
+// новым в следующей области (см. rebuild_ring)
+const unsigned int RING_AREAS = 4;
+
+// Заголовок сегмента разделяемой памяти
+struct SharedHeader {
+  // Количество незавершённых чанков. Пишет только координатор, пересчитывая
+  // его по chunk_state, рабочие лишь читают, чтобы знать, когда завершиться
+  std::atomic<uint32_t> remaining;
+  std::atomic<uint32_t> ring_index; // Текущая область кольца
+  unsigned int data_size;
+  unsigned int chunk_size;
+  unsigned int chunks_count;
+};
+
+// Указатели на части сегмента (одинаковы во всех процессах после fork)
+struct Segment {
+  SharedHeader *header;
+  char *ring_areas[RING_AREAS];
+  size_t ring_capacity;
+  std::atomic<int32_t> *chunk_state;
+  float *partial_results; // Результат reduce по каждому чанку
+  const float *input;     // Исходные данные (не изменяются)
+  float *output;          // Результат map
+  size_t bytes;
+};
+
+// Параметры MapReduce в многопроцессном режиме
+struct MpMapReduceParams {
+  const float *data;                  // Массив данных
+  unsigned int data_size;             // Размер массива
+  float (*map_func)(float);           // Функция map
+  float (*reduce_func)(float, float); // Функция reduce
+  unsigned int processes_count;       // Количество рабочих процессов
+  unsigned int chunk_size;            // Размер порции работы
+  int crash_worker; // Слот процесса, аварийно завершающегося (-1 - нет)
+};
+
+static size_t align_up(size_t value) { return (value + 63) & ~size_t(63); }
+
+static size_t ring_capacity(unsigned int chunks_count) {
+  // Запас вдвое: повторно поставленные чанки не должны упираться в ёмкость
+  size_t capacity = 1;
+  while (capacity < 2 * size_t(chunks_count))
+    capacity <<= 1;
+  return capacity;
+}
+
+// Создание сегмента POSIX shared memory и разметка его содержимого
+Segment create_segment(const MpMapReduceParams *params) {
+  unsigned int chunks_count =
+      (params->data_size + params->chunk_size - 1) / params->chunk_size;
+  size_t capacity = ring_capacity(chunks_count);
+
+  size_t ring_offset = align_up(sizeof(SharedHeader));
+  size_t ring_bytes = align_up(MpmcRing<uint32_t>::bytes_for(capacity));
+  size_t state_offset = ring_offset + RING_AREAS * ring_bytes;
+  size_t partial_offset =
+      align_up(state_offset + chunks_count * sizeof(std::atomic<int32_t>));
+  size_t input_offset =
+      align_up(partial_offset + chunks_count * sizeof(float));
+  size_t output_offset =
+      align_up(input_offset + params->data_size * sizeof(float));
+  size_t bytes = align_up(output_offset + params->data_size * sizeof(float));
+
+  std::string name = "/mp_map_reduce." + std::to_string(getpid());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1)
+    err_exit(errno, "Cannot create shared memory segment");
+  if (ftruncate(fd, bytes) == -1)
+    err_exit(errno, "Cannot resize shared memory segment");
+  void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED)
+    err_exit(errno, "Cannot map shared memory segment");
+  // Отображение наследуется дочерними процессами, имя больше не нужно
+  close(fd);
+  shm_unlink(name.c_str());
+
+  char *bytes_ptr = static_cast<char *>(base);
+  Segment seg;
+  seg.header = new (bytes_ptr) SharedHeader;
+  seg.header->data_size = params->data_size;
+  seg.header->chunk_size = params->chunk_size;
+  seg.header->chunks_count = chunks_count;
+  seg.header->remaining.store(chunks_count);
+  seg.header->ring_index.store(0);
+  for (unsigned int k = 0; k < RING_AREAS; k++)
+    seg.ring_areas[k] = bytes_ptr + ring_offset + k * ring_bytes;
+  seg.ring_capacity = capacity;
+  MpmcRing<uint32_t> *ring =
+      MpmcRing<uint32_t>::create(seg.ring_areas[0], capacity);
+  seg.chunk_state =
+      reinterpret_cast<std::atomic<int32_t> *>(bytes_ptr + state_offset);
+  seg.partial_results = reinterpret_cast<float *>(bytes_ptr + partial_offset);
+  seg.output = reinterpret_cast<float *>(bytes_ptr + output_offset);
+  float *input = reinterpret_cast<float *>(bytes_ptr + input_offset);
+  std::memcpy(input, params->data, params->data_size * sizeof(float));
+  seg.input = input;
+  seg.bytes = bytes;
+
+  for (unsigned int c = 0; c < chunks_count; c++) {
+    new (&seg.chunk_state[c]) std::atomic<int32_t>(CHUNK_QUEUED);
+    ring->push(c);
+  }
+  return seg;
+}
+
+MpmcRing<uint32_t> *current_ring(Segment &seg) {
+  return reinterpret_cast<MpmcRing<uint32_t> *>(
+      seg.ring_areas[seg.header->ring_index.load()]);
+}
+
+// Процесс, погибший внутри pop() между захватом позиции и освобождением
+// ячейки, оставляет её занятой навсегда: когда запись дойдёт до неё по
+// кругу, push() будет сообщать о переполнении. Такое кольцо не чинится -
+// координатор создаёт новое в ещё не использованной области и кладёт в него
+// все чанки в состоянии CHUNK_QUEUED. Рабочие, ещё читающие старое кольцо,
+// могут достать оттуда уже поставленный чанк - его отсеет захват по CAS.
+void rebuild_ring(Segment &seg) {
+  unsigned int next = seg.header->ring_index.load() + 1;
+  if (next >= RING_AREAS) {
+    std::cerr << "MapReduce failed: task ring wedged " << RING_AREAS
+              << " times" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  MpmcRing<uint32_t> *ring =
+      MpmcRing<uint32_t>::create(seg.ring_areas[next], seg.ring_capacity);
+  for (uint32_t c = 0; c < seg.header->chunks_count; c++) {
+    if (seg.chunk_state[c].load() == CHUNK_QUEUED)
+      ring->push(c);
+  }
+  seg.header->ring_index.store(next);
+  std::cout << "Task ring wedged, rebuilt in area " << next + 1 << std::endl;
+}
+
+// Постановка чанка (уже в состоянии CHUNK_QUEUED) обратно в кольцо.
+// Ёмкость кольца вдвое больше числа чанков, поэтому затянувшееся
+// "переполнение" означает заклинившую ячейку
+void requeue_chunk(Segment &seg, uint32_t chunk) {
+  for (unsigned int attempt = 0; attempt < 100; attempt++) {
+    if (current_ring(seg)->push(chunk))
+      return;
+    usleep(100);
+  }
+  rebuild_ring(seg);
+}
+
+// Пересчёт незавершённых чанков по chunk_state. Отдельный счётчик, который
+// уменьшал бы сам рабочий, разошёлся бы с состоянием, если процесс погибнет
+// между записью CHUNK_DONE и уменьшением
+uint32_t update_remaining(Segment &seg) {
+  uint32_t remaining = 0;
+  for (uint32_t c = 0; c < seg.header->chunks_count; c++) {
+    if (seg.chunk_state[c].load() != CHUNK_DONE)
+      remaining++;
+  }
+  seg.header->remaining.store(remaining);
+  return remaining;
+}
+
+// Рабочий процесс: забирает чанки из кольца, пока все не будут завершены
+void worker_job(Segment &seg, const MpMapReduceParams *params, int slot,
+                bool crash) {
+  auto start = high_resolution_clock::now();
+  unsigned int chunks_done = 0;
+
+  while (true) {
+    uint32_t chunk;
+    if (!current_ring(seg)->pop(chunk)) {
+      if (seg.header->remaining.load() == 0)
+        break;
+      usleep(100); // Ожидание повторно поставленных чанков
+      continue;
+    }
+
+    // Захват чанка; неудача означает, что его уже выполнил или выполняет
+    // другой процесс (чанк мог попасть в кольцо повторно)
+    int32_t expected = CHUNK_QUEUED;
+    if (!seg.chunk_state[chunk].compare_exchange_strong(expected, slot))
+      continue;
+
+    unsigned int begin = chunk * seg.header->chunk_size;
+    unsigned int end =
+        std::min(begin + seg.header->chunk_size, seg.header->data_size);
+    float result = 0.0f;
+    for (unsigned int i = begin; i < end; i++) {
+      seg.output[i] = params->map_func(seg.input[i]);
+      usleep(1000); // Симуляция вычислительной нагрузки
+      if (crash && i == begin + (end - begin) / 2)
+        abort(); // Имитация сбоя посреди чанка
+      result = i == begin ? seg.output[i]
+                          : params->reduce_func(result, seg.output[i]);
+    }
+    seg.partial_results[chunk] = result;
+
+    seg.chunk_state[chunk].store(CHUNK_DONE);
+    chunks_done++;
+  }
+
+  auto end = high_resolution_clock::now();
+  // Одна запись в поток на строку: вывод разных процессов не перемешивается
+  std::ostringstream line;
+  line << "Worker " << slot + 1 << " (pid " << getpid()
+       << ") chunks: " << chunks_done << ", execution time: "
+       << duration_cast<microseconds>(end - start).count() << " us\n";
+  std::string text = line.str();
+  ssize_t written = write(STDOUT_FILENO, text.data(), text.size());
+  (void)written;
+}
+
+pid_t spawn_worker(Segment &seg, const MpMapReduceParams *params, int slot,
+                   bool crash) {
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid == -1)
+    err_exit(errno, "Cannot fork worker process");
+  if (pid == 0) {
+    worker_job(seg, params, slot, crash);
+    _exit(EXIT_SUCCESS);
+  }
+  return pid;
+}
+
+// Возврат в кольцо чанков, которые выполнял завершившийся процесс
+unsigned int reclaim_chunks(Segment &seg, int slot) {
+  unsigned int reclaimed = 0;
+  for (uint32_t c = 0; c < seg.header->chunks_count; c++) {
+    int32_t expected = slot;
+    if (seg.chunk_state[c].compare_exchange_strong(expected, CHUNK_QUEUED)) {
+      requeue_chunk(seg, c);
+      reclaimed++;
+    }
+  }
+  return reclaimed;
+}
+
+// Процесс мог погибнуть между извлечением чанка из кольца и его захватом.
+// Такой чанк остаётся в состоянии CHUNK_QUEUED вне кольца - возвращаем
+// его, если работа стоит: кольцо пусто и ни один чанк не выполняется
+void recover_lost_chunks(Segment &seg) {
+  if (current_ring(seg)->size_approx() != 0)
+    return;
+  for (uint32_t c = 0; c < seg.header->chunks_count; c++) {
+    if (seg.chunk_state[c].load() >= 0)
+      return;
+  }
+  for (uint32_t c = 0; c < seg.header->chunks_count; c++) {
+    if (seg.chunk_state[c].load() == CHUNK_QUEUED)
+      requeue_chunk(seg, c);
+  }
+}
+
+// Координатор: запускает рабочие процессы, перезапускает упавшие и
+// объединяет частичные результаты
+float mp_map_reduce(MpMapReduceParams *params, float *output) {
+  auto start_total = high_resolution_clock::now();
+
+  Segment seg = create_segment(params);
+  unsigned int max_restarts = 2 * params->processes_count;
+  unsigned int restarts = 0;
+
+  std::vector<pid_t> workers(params->processes_count);
+  for (unsigned int i = 0; i < params->processes_count; i++) {
+    workers[i] = spawn_worker(seg, params, i,
+                              static_cast<int>(i) == params->crash_worker);
+  }
+
+  unsigned int alive = params->processes_count;
+  uint32_t last_remaining = seg.header->remaining.load();
+  unsigned int idle_ticks = 0;
+  while (alive > 0) {
+    int status;
+    pid_t pid = waitpid(-1, &status, WNOHANG);
+    if (pid == -1)
+      err_exit(errno, "waitpid failed");
+
+    if (pid == 0) {
+      // Раз в ~100 мс без прогресса проверяем, не потерян ли чанк
+      usleep(1000);
+      uint32_t remaining = update_remaining(seg);
+      idle_ticks = remaining == last_remaining ? idle_ticks + 1 : 0;
+      last_remaining = remaining;
+      if (remaining > 0 && idle_ticks >= 100) {
+        recover_lost_chunks(seg);
+        idle_ticks = 0;
+      }
+      continue;
+    }
+
+    int slot = -1;
+    for (unsigned int i = 0; i < workers.size(); i++) {
+      if (workers[i] == pid)
+        slot = i;
+    }
+    if (slot == -1)
+      continue;
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+      workers[slot] = 0;
+      alive--;
+      continue;
+    }
+
+    unsigned int reclaimed = reclaim_chunks(seg, slot);
+    std::cout << "Worker " << slot + 1 << " (pid " << pid << ") failed ("
+              << (WIFSIGNALED(status) ? strsignal(WTERMSIG(status))
+                                      : "non-zero exit")
+              << "), chunks requeued: " << reclaimed << std::endl;
+
+    if (update_remaining(seg) > 0 && restarts < max_restarts) {
+      restarts++;
+      workers[slot] = spawn_worker(seg, params, slot, false);
+    } else {
+      workers[slot] = 0;
+      alive--;
+    }
+  }
+
+  if (update_remaining(seg) != 0) {
+    std::cerr << "MapReduce failed: " << seg.header->remaining.load()
+              << " chunks were not completed" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Финальное объединение результатов в порядке чанков
+  float final_result = seg.partial_results[0];
+  for (unsigned int c = 1; c < seg.header->chunks_count; c++) {
+    final_result = params->reduce_func(final_result, seg.partial_results[c]);
+  }
+  std::memcpy(output, seg.output, params->data_size * sizeof(float));
+  munmap(seg.header, seg.bytes);
+
+  auto end_total = high_resolution_clock::now();
+  std::cout << "Worker restarts: " << restarts << std::endl;
+  std::cout << "Total MapReduce execution time: "
+            << duration_cast<microseconds>(end_total - start_total).count()
+            << " us" << std::endl;
+
+  return final_result;
+}
+
+void initialize_array(unsigned int length, float *arr) {
+  for (unsigned int i = 0; i < length; i++) {
+    arr[i] = static_cast<float>(i);
+  }
+}
+
+// Пример функций map и reduce
+float map_func(float x) {
+  return x * x; // Возведение в квадрат
+}
+
+float reduce_func(float a, float b) {
+  return a + b; // Суммирование
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <array_length> <processes_count> [chunk_size]"
+                 " [crash_worker]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  unsigned int array_length = atoi(argv[1]);
+  unsigned int processes_count = atoi(argv[2]);
+  if (array_length == 0 || processes_count == 0) {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+  processes_count = std::min(processes_count, array_length);
+
+  // По умолчанию ~4 чанка на процесс, чтобы было что перераспределять
+  unsigned int chunk_size =
+      argc > 3 ? atoi(argv[3])
+               : std::max(1u, array_length / (processes_count * 4));
+  int crash_worker = argc > 4 ? atoi(argv[4]) - 1 : -1;
+  if (chunk_size == 0) {
+    std::cerr << "Invalid chunk size" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<float[]> data(new float[array_length]);
+  initialize_array(array_length, data.get());
+
+  MpMapReduceParams params = {data.get(),  array_length,    map_func,
+                              reduce_func, processes_count, chunk_size,
+                              crash_worker};
+  float result = mp_map_reduce(&params, data.get());
+
+  std::cout << "\nMapReduce result: " << result << std::endl;
+  std::cout << "Processes used: " << processes_count
+            << ", chunk size: " << chunk_size << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <vector>
+
+using namespace std::chrono;
+
+// Размер блока, который проходит через все слитые этапы, пока лежит в кэше
+// (4096 float = 16 КБ, помещается в L1d вместе с входными данными)
+const unsigned int BLOCK_SIZE = 4096;
+
+// Запуск job(thread_index, begin, end) на threads_count потоках POSIX,
+// каждому потоку достаётся непрерывный диапазон [begin, end) из size
+struct ParallelForParams {
+  const std::function<void(unsigned int, unsigned int, unsigned int)> *job;
+  unsigned int thread_index;
+  unsigned int begin;
+  unsigned int end;
+};
+
+void *parallel_for_job(void *arg) {
+  ParallelForParams *params = static_cast<ParallelForParams *>(arg);
+  (*params->job)(params->thread_index, params->begin, params->end);
+  return nullptr;
+}
+
+void parallel_for(
+    unsigned int threads_count, unsigned int size,
+    const std::function<void(unsigned int, unsigned int, unsigned int)> &job) {
+  std::vector<pthread_t> threads(threads_count);
+  std::vector<ParallelForParams> params(threads_count);
+  unsigned int batch_size = size / threads_count;
+  unsigned int rest = size % threads_count;
+
+  unsigned int begin = 0;
+  for (unsigned int i = 0; i < threads_count; ++i) {
+    // Остаток распределяется по первым потокам, чтобы диапазоны шли по порядку
+    unsigned int current_batch_size = batch_size + (i < rest ? 1 : 0);
+    params[i] = {&job, i, begin, begin + current_batch_size};
+    begin += current_batch_size;
+    pthread_create(&threads[i], nullptr, parallel_for_job, &params[i]);
+  }
+
+  for (auto &thread : threads) {
+    pthread_join(thread, nullptr);
+  }
+}
+
+// Этап конвейера
+enum class StageKind { Map, Filter, Scan };
+
+struct Stage {
+  StageKind kind;
+  float (*map_func)(float);         // Для Map
+  bool (*filter_func)(float);       // Для Filter
+  float (*scan_func)(float, float); // Для Scan (ассоциативная операция)
+};
+
+// Накопленное значение свёртки; has == false - пустая свёртка
+struct Carry {
+  float value;
+  bool has;
+};
+
+Carry combine(float (*op)(float, float), Carry a, Carry b) {
+  if (!a.has)
+    return b;
+  if (!b.has)
+    return a;
+  return {op(a.value, b.value), true};
+}
+
+// Применение этапов [0, stage_end) к блоку buf длины n на месте.
+// Фильтр уплотняет блок, scan продолжает накопление из carries.
+// Возвращает новую длину блока.
+unsigned int apply_stages(const std::vector<Stage> &stages,
+                          unsigned int stage_end, float *buf, unsigned int n,
+                          Carry *carries) {
+  unsigned int scan_index = 0;
+  for (unsigned int s = 0; s < stage_end; s++) {
+    const Stage &stage = stages[s];
+    switch (stage.kind) {
+    case StageKind::Map:
+      for (unsigned int i = 0; i < n; i++)
+        buf[i] = stage.map_func(buf[i]);
+      break;
+    case StageKind::Filter: {
+      unsigned int kept = 0;
+      for (unsigned int i = 0; i < n; i++) {
+        if (stage.filter_func(buf[i]))
+          buf[kept++] = buf[i];
+      }
+      n = kept;
+      break;
+    }
+    case StageKind::Scan: {
+      Carry &carry = carries[scan_index++];
+      for (unsigned int i = 0; i < n; i++) {
+        carry.value = carry.has ? stage.scan_func(carry.value, buf[i]) : buf[i];
+        carry.has = true;
+        buf[i] = carry.value;
+      }
+      break;
+    }
+    }
+  }
+  return n;
+}
+
+// Ленивый конвейер операторов над массивом float.
+// map/filter/scan только записывают этапы; reduce/collect выполняют их,
+// прогоняя каждый блок входных данных через все этапы за один проход.
+// Каждый scan требует одного дополнительного прохода: сначала потоки
+// считают свёртку своей части (reduce-then-scan), затем по ней строятся
+// смещения, с которыми потоки продолжают накопление.
+class Pipeline {
+public:
+  Pipeline(const float *data, unsigned int data_size,
+           unsigned int threads_count)
+      : data(data), data_size(data_size),
+        threads_count(std::max(1u, std::min(threads_count, data_size))) {}
+
+  Pipeline &map(float (*func)(float)) {
+    stages.push_back({StageKind::Map, func, nullptr, nullptr});
+    return *this;
+  }
+
+  Pipeline &filter(bool (*func)(float)) {
+    stages.push_back({StageKind::Filter, nullptr, func, nullptr});
+    return *this;
+  }
+
+  Pipeline &scan(float (*func)(float, float)) {
+    stages.push_back({StageKind::Scan, nullptr, nullptr, func});
+    return *this;
+  }
+
+  // Свёртка результата конвейера; init - значение для пустого результата
+  float reduce(float (*reduce_func)(float, float), float init) const {
+    std::vector<std::vector<Carry>> offsets = scan_offsets();
+    std::vector<Carry> partial_results(threads_count, Carry{0.0f, false});
+
+    parallel_for(threads_count, data_size,
+                 [&](unsigned int t, unsigned int begin, unsigned int end) {
+                   std::vector<Carry> carries = offsets[t];
+                   std::unique_ptr<float[]> buf(new float[BLOCK_SIZE]);
+                   Carry result = {0.0f, false};
+                   for_each_block(begin, end, buf.get(), stages.size(),
+                                  carries.data(),
+                                  [&](const float *block, unsigned int n) {
+                                    for (unsigned int i = 0; i < n; i++) {
+                                      result = combine(reduce_func, result,
+                                                       {block[i], true});
+                                    }
+                                  });
+                   partial_results[t] = result;
+                 });
+
+    Carry final_result = {0.0f, false};
+    for (const Carry &partial : partial_results)
+      final_result = combine(reduce_func, final_result, partial);
+    return final_result.has ? final_result.value : init;
+  }
+
+  // Материализация результата (параллельное уплотнение потока)
+  std::vector<float> collect() const {
+    std::vector<std::vector<Carry>> offsets = scan_offsets();
+    std::vector<std::vector<float>> parts(threads_count);
+
+    parallel_for(threads_count, data_size,
+                 [&](unsigned int t, unsigned int begin, unsigned int end) {
+                   std::vector<Carry> carries = offsets[t];
+                   std::unique_ptr<float[]> buf(new float[BLOCK_SIZE]);
+                   for_each_block(begin, end, buf.get(), stages.size(),
+                                  carries.data(),
+                                  [&](const float *block, unsigned int n) {
+                                    parts[t].insert(parts[t].end(), block,
+                                                    block + n);
+                                  });
+                 });
+
+    // Позиции частей в выходном массиве - префиксная сумма их длин
+    std::vector<size_t> positions(threads_count + 1, 0);
+    for (unsigned int t = 0; t < threads_count; t++)
+      positions[t + 1] = positions[t] + parts[t].size();
+
+    std::vector<float> result(positions[threads_count]);
+    parallel_for(threads_count, threads_count,
+                 [&](unsigned int, unsigned int begin, unsigned int end) {
+                   for (unsigned int t = begin; t < end; t++) {
+                     std::copy(parts[t].begin(), parts[t].end(),
+                               result.begin() + positions[t]);
+                   }
+                 });
+    return result;
+  }
+
+private:
+  template <typename Sink>
+  void for_each_block(unsigned int begin, unsigned int end, float *buf,
+                      unsigned int stage_end, Carry *carries,
+                      Sink &&sink) const {
+    for (unsigned int block = begin; block < end; block += BLOCK_SIZE) {
+      unsigned int n = std::min(BLOCK_SIZE, end - block);
+      std::memcpy(buf, data + block, n * sizeof(float));
+      n = apply_stages(stages, stage_end, buf, n, carries);
+      sink(buf, n);
+    }
+  }
+
+  // Начальные значения накопления каждого scan для каждого потока:
+  // свёртка входа этого scan во всех предыдущих потоках
+  std::vector<std::vector<Carry>> scan_offsets() const {
+    std::vector<unsigned int> scan_stages;
+    for (unsigned int s = 0; s < stages.size(); s++) {
+      if (stages[s].kind == StageKind::Scan)
+        scan_stages.push_back(s);
+    }
+
+    std::vector<std::vector<Carry>> offsets(
+        threads_count,
+        std::vector<Carry>(scan_stages.size(), Carry{0.0f, false}));
+
+    for (unsigned int j = 0; j < scan_stages.size(); j++) {
+      unsigned int stage_end = scan_stages[j];
+      float (*scan_func)(float, float) = stages[stage_end].scan_func;
+      std::vector<Carry> totals(threads_count, Carry{0.0f, false});
+
+      parallel_for(threads_count, data_size,
+                   [&](unsigned int t, unsigned int begin, unsigned int end) {
+                     std::vector<Carry> carries = offsets[t];
+                     std::unique_ptr<float[]> buf(new float[BLOCK_SIZE]);
+                     Carry total = {0.0f, false};
+                     for_each_block(begin, end, buf.get(), stage_end,
+                                    carries.data(),
+                                    [&](const float *block, unsigned int n) {
+                                      for (unsigned int i = 0; i < n; i++) {
+                                        total = combine(scan_func, total,
+                                                        {block[i], true});
+                                      }
+                                    });
+                     totals[t] = total;
+                   });
+
+      Carry running = {0.0f, false};
+      for (unsigned int t = 0; t < threads_count; t++) {
+        offsets[t][j] = running;
+        running = combine(scan_func, running, totals[t]);
+      }
+    }
+    return offsets;
+  }
+
+  const float *data;
+  unsigned int data_size;
+  unsigned int threads_count;
+  std::vector<Stage> stages;
+};
+
+// Тот же конвейер в виде отдельных проходов в стиле map_reduce:
+// каждый этап - отдельный запуск потоков и материализованный массив
+std::vector<float> run_stage_pass(const Stage &stage,
+                                  const std::vector<float> &input,
+                                  unsigned int threads_count) {
+  unsigned int size = input.size();
+  threads_count = std::max(1u, std::min(threads_count, size));
+  std::vector<float> output;
+
+  switch (stage.kind) {
+  case StageKind::Map:
+    output.resize(size);
+    parallel_for(threads_count, size,
+                 [&](unsigned int, unsigned int begin, unsigned int end) {
+                   for (unsigned int i = begin; i < end; i++)
+                     output[i] = stage.map_func(input[i]);
+                 });
+    break;
+  case StageKind::Filter: {
+    // Подсчёт, префиксная сумма счётчиков, запись
+    std::vector<unsigned int> counts(threads_count + 1, 0);
+    parallel_for(threads_count, size,
+                 [&](unsigned int t, unsigned int begin, unsigned int end) {
+                   unsigned int count = 0;
+                   for (unsigned int i = begin; i < end; i++)
+                     count += stage.filter_func(input[i]);
+                   counts[t + 1] = count;
+                 });
+    for (unsigned int t = 0; t < threads_count; t++)
+      counts[t + 1] += counts[t];
+    output.resize(counts[threads_count]);
+    parallel_for(threads_count, size,
+                 [&](unsigned int t, unsigned int begin, unsigned int end) {
+                   unsigned int pos = counts[t];
+                   for (unsigned int i = begin; i < end; i++) {
+                     if (stage.filter_func(input[i]))
+                       output[pos++] = input[i];
+                   }
+                 });
+    break;
+  }
+  case StageKind::Scan: {
+    if (size == 0)
+      break;
+    output.resize(size);
+    std::vector<Carry> totals(threads_count, Carry{0.0f, false});
+    parallel_for(threads_count, size,
+                 [&](unsigned int t, unsigned int begin, unsigned int end) {
+                   Carry total = {0.0f, false};
+                   for (unsigned int i = begin; i < end; i++)
+                     total = combine(stage.scan_func, total, {input[i], true});
+                   totals[t] = total;
+                 });
+    std::vector<Carry> offsets(threads_count);
+    Carry running = {0.0f, false};
+    for (unsigned int t = 0; t < threads_count; t++) {
+      offsets[t] = running;
+      running = combine(stage.scan_func, running, totals[t]);
+    }
+    parallel_for(threads_count, size,
+                 [&](unsigned int t, unsigned int begin, unsigned int end) {
+                   Carry carry = offsets[t];
+                   for (unsigned int i = begin; i < end; i++) {
+                     carry = combine(stage.scan_func, carry, {input[i], true});
+                     output[i] = carry.value;
+                   }
+                 });
+    break;
+  }
+  }
+  return output;
+}
+
+float run_separate_passes(const std::vector<Stage> &stages, const float *data,
+                          unsigned int data_size,
+                          float (*reduce_func)(float, float), float init,
+                          unsigned int threads_count) {
+  std::vector<float> current(data, data + data_size);
+  for (const Stage &stage : stages)
+    current = run_stage_pass(stage, current, threads_count);
+
+  if (current.empty())
+    return init;
+  unsigned int size = current.size();
+  threads_count = std::max(1u, std::min(threads_count, size));
+  std::vector<float> partial_results(threads_count);
+  parallel_for(threads_count, size,
+               [&](unsigned int t, unsigned int begin, unsigned int end) {
+                 float result = current[begin];
+                 for (unsigned int i = begin + 1; i < end; i++)
+                   result = reduce_func(result, current[i]);
+                 partial_results[t] = result;
+               });
+  float final_result = partial_results[0];
+  for (unsigned int t = 1; t < threads_count; t++)
+    final_result = reduce_func(final_result, partial_results[t]);
+  return final_result;
+}
+
+// Значения ограничены, чтобы оставаться точными целыми во float при любой
+// длине массива (float(i) теряет целые после 2^24)
+void initialize_array(unsigned int length, float *arr) {
+  for (unsigned int i = 0; i < length; i++) {
+    arr[i] = static_cast<float>(i % 1000);
+  }
+}
+
+// Модуль для scan: суммы остаются целыми меньше 2^21 и вычисляются точно,
+// поэтому результат не зависит от разбиения на потоки
+const float SCAN_MODULUS = 1 << 20;
+
+// Пример цепочки: map -> filter -> inclusive scan (+ mod 2^20) -> reduce (max)
+float map_func(float x) {
+  return static_cast<float>(static_cast<unsigned int>(x) % 10);
+}
+
+bool filter_func(float x) { return x >= 5.0f; }
+
+float scan_func(float a, float b) { return std::fmod(a + b, SCAN_MODULUS); }
+
+float reduce_func(float a, float b) { return std::max(a, b); }
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <array_length> <threads_count> [repeats]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  unsigned int array_length = atoi(argv[1]);
+  unsigned int threads_count = atoi(argv[2]);
+  unsigned int repeats = argc > 3 ? atoi(argv[3]) : 5;
+  if (array_length == 0 || threads_count == 0 || repeats == 0) {
+    std::cerr << "Invalid arguments" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<float[]> data(new float[array_length]);
+  initialize_array(array_length, data.get());
+
+  Pipeline pipeline(data.get(), array_length, threads_count);
+  pipeline.map(map_func).filter(filter_func).scan(scan_func);
+  std::vector<Stage> stages = {
+      {StageKind::Map, map_func, nullptr, nullptr},
+      {StageKind::Filter, nullptr, filter_func, nullptr},
+      {StageKind::Scan, nullptr, nullptr, scan_func},
+  };
+
+  // Проверка слитого конвейера по последовательной реализации
+  std::vector<float> reference;
+  float running = 0.0f;
+  for (unsigned int i = 0; i < array_length; i++) {
+    float x = map_func(data[i]);
+    if (filter_func(x)) {
+      running = reference.empty() ? x : scan_func(running, x);
+      reference.push_back(running);
+    }
+  }
+  std::vector<float> collected = pipeline.collect();
+  bool collect_ok = collected.size() == reference.size();
+  for (size_t i = 0; collect_ok && i < reference.size(); i++)
+    collect_ok = collected[i] == reference[i];
+  if (!collect_ok) {
+    std::cerr << "Pipeline collect() does not match sequential result"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  float fused_result = 0.0f;
+  float separate_result = 0.0f;
+  long long fused_us = 0;
+  long long separate_us = 0;
+  for (unsigned int r = 0; r < repeats; r++) {
+    auto start = high_resolution_clock::now();
+    fused_result = pipeline.reduce(reduce_func, 0.0f);
+    auto middle = high_resolution_clock::now();
+    separate_result = run_separate_passes(stages, data.get(), array_length,
+                                          reduce_func, 0.0f, threads_count);
+    auto end = high_resolution_clock::now();
+    fused_us += duration_cast<microseconds>(middle - start).count();
+    separate_us += duration_cast<microseconds>(end - middle).count();
+  }
+
+  if (fused_result != separate_result) {
+    std::cerr << "Fused and separate results differ: " << fused_result
+              << " vs " << separate_result << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Pipeline: map -> filter -> scan(+ mod 2^20) -> reduce(max)" << std::endl;
+  std::cout << "Elements: " << array_length << ", kept by filter: "
+            << reference.size() << ", threads: " << threads_count << std::endl;
+  std::cout << "Result: " << fused_result << std::endl;
+  std::cout << "Fused pipeline average time: " << fused_us / repeats << " us"
+            << std::endl;
+  std::cout << "Separate passes average time: " << separate_us / repeats
+            << " us" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -1,3 +1,6 @@
+#include "../Common/arena.h"
+#include "../Common/autotune.h"
+
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
@@ -6,6 +9,8 @@
 #include <iostream>
 #include <pthread.h>
 #include <queue>
+#include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -16,10 +21,12 @@ using namespace std;
     exit(EXIT_FAILURE);                                                        \
   }
 
+typedef vector<bool, ArenaAllocator<bool>> Sieve;
+
 struct Task {
   int start;
   int end;
-  vector<bool> *sieve;
+  Sieve *sieve;
   const vector<int> *primes;
 };
 
@@ -70,12 +77,15 @@ void *thread_job(void *arg) {
 
 int main(int argc, char *argv[]) {
   if (argc != 3) {
-    cerr << "Usage: " << argv[0] << " <max_number> <thread_count>" << endl;
+    cerr << "Usage: " << argv[0] << " <max_number> <thread_count|auto>"
+         << endl;
     return EXIT_FAILURE;
   }
 
   MAX_NUM = atoi(argv[1]);
-  THREAD_COUNT = atoi(argv[2]);
+  bool autotune = string(argv[2]) == "auto";
+  THREAD_COUNT =
+      autotune ? max(1u, thread::hardware_concurrency()) : atoi(argv[2]);
 
   if (MAX_NUM <= 1 || THREAD_COUNT <= 0) {
     cerr << "Invalid arguments" << endl;
@@ -83,10 +93,13 @@ int main(int argc, char *argv[]) {
   }
 
   auto start_time = chrono::high_resolution_clock::now();
+  PageFaultReport fault_report;
 
   pthread_mutex_init(&queue_mutex, NULL);
   pthread_cond_init(&queue_cond, NULL);
-  vector<bool> sieve(MAX_NUM + 1, true);
+  Sieve sieve(MAX_NUM + 1, true, ArenaAllocator<bool>(THREAD_COUNT));
+  // Отдельно - стоимость первого касания: здесь видна разница режимов арены
+  fault_report.print(cout, "Sieve allocation");
   sieve[0] = sieve[1] = false;
 
   int sqrt_n = sqrt(MAX_NUM);
@@ -100,6 +113,32 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  int segment_size;
+  if (autotune) {
+    Autotuner tuner("primes");
+    // Проба на хвосте настоящего решета: повторное вычёркивание безвредно
+    tuner.calibrate(
+        [&](size_t count) {
+          do_task({MAX_NUM - static_cast<int>(count) + 1, MAX_NUM, &sieve,
+                   &small_primes});
+        },
+        MAX_NUM - sqrt_n);
+    tuner.print(cout);
+    THREAD_COUNT = tuner.pick_threads(MAX_NUM);
+    segment_size = tuner.pick_chunk(MAX_NUM, THREAD_COUNT, sqrt_n + 1, 1.0 / 8);
+  } else {
+    segment_size = MAX_NUM / THREAD_COUNT;
+    if (segment_size < sqrt_n)
+      segment_size = sqrt_n + 1;
+  }
+  // vector<bool> хранит биты 64-битными словами, а запись бита - это
+  // неатомарное чтение-изменение-запись всего слова. Сегменты начинаются
+  // с 0 и кратны 64, поэтому соседние потоки никогда не делят слово
+  segment_size = (segment_size + 63) / 64 * 64;
+  // Лишние потоки сверх числа сегментов только ждали бы на queue_cond
+  int segments_count = MAX_NUM / segment_size + 1;
+  THREAD_COUNT = min(THREAD_COUNT, segments_count);
+
   vector<pthread_t> threads(THREAD_COUNT);
   for (int i = 0; i < THREAD_COUNT; i++) {
     int err = pthread_create(&threads[i], NULL, thread_job, NULL);
@@ -107,10 +146,8 @@ int main(int argc, char *argv[]) {
       err_exit(err, "Cannot create thread");
   }
 
-  int segment_size = MAX_NUM / THREAD_COUNT;
-  if (segment_size < sqrt_n)
-    segment_size = sqrt_n + 1;
-  for (int i = 2; i <= MAX_NUM; i += segment_size) {
+  // Вычёркивание начинается с p * p >= 4, так что 0 и 1 не затрагиваются
+  for (int i = 0; i <= MAX_NUM; i += segment_size) {
     Task task;
     task.start = i;
     task.end = min(i + segment_size - 1, MAX_NUM);
@@ -167,7 +204,10 @@ int main(int argc, char *argv[]) {
   cout << "Total prime numbers found: " << prime_count << "\n";
   cout << "Execution time: " << duration.count() << " ms\n";
   cout << "Threads used: " << THREAD_COUNT << "\n";
+  cout << "Segment size: " << segment_size << "\n";
   cout << "Prime numbers written to 'primes.txt'\n";
+  fault_report.print(cout, "Sieve total");
+  Arena::instance().print_stats(cout);
 
   pthread_mutex_destroy(&queue_mutex);
   pthread_cond_destroy(&queue_cond);